@@ -0,0 +1,36 @@
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <fcp++/codec/base64.hpp>
+#include <string>
+
+TEST_CASE("base64 encode", "[codec::base64]")
+{
+  for (std::size_t size : { 16, 256, 4096, 65536 }) {
+    std::string input(size, '\0');
+    for (std::size_t i = 0; i < size; i++) {
+      input[i] = static_cast<char>(i * 31);
+    }
+
+    BENCHMARK("encode " + std::to_string(size) + " bytes")
+    {
+      return fcp::codec::base64::encode(input);
+    };
+  }
+}
+
+TEST_CASE("base64 decode", "[codec::base64]")
+{
+  for (std::size_t size : { 16, 256, 4096, 65536 }) {
+    std::string input(size, '\0');
+    for (std::size_t i = 0; i < size; i++) {
+      input[i] = static_cast<char>(i * 31);
+    }
+    const std::string encoded = fcp::codec::base64::encode(input);
+
+    BENCHMARK("decode " + std::to_string(size) + " bytes")
+    {
+      return fcp::codec::base64::decode(encoded);
+    };
+  }
+}
@@ -0,0 +1,113 @@
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <fcp++/protocol/message.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using fcp::protocol::Message;
+
+namespace {
+
+/* What a node sends after ClientHello when a client calls a plugin many
+ * times, then fetches a file */
+std::string
+recorded_stream(std::size_t replies, std::size_t data)
+{
+  std::string stream = "NodeHello\n"
+                       "Build=1503\n"
+                       "ConnectionIdentifier=5f2b6a0e6e4f7c1d\n"
+                       "CompressionCodecs=3 - GZIP(0), BZIP2(1), LZMA_NEW(2)\n"
+                       "FCPVersion=2.0\n"
+                       "Node=Fred\n"
+                       "NodeLanguage=ENGLISH\n"
+                       "Revision=build01503\n"
+                       "Testnet=false\n"
+                       "Version=Fred,0.7,1.0,1503\n"
+                       "EndMessage\n";
+
+  for (std::size_t i = 0; i < replies; i++) {
+    const std::string identifier = "FCPPluginMessage-" + std::to_string(i);
+    stream += "FCPPluginReply\n"
+              "PluginName=plugins.HelloFCP.HelloFCP\n"
+              "Identifier=" +
+              identifier +
+              "\n"
+              "Replies.Status=OK\n"
+              "Replies.Echo=" +
+              identifier + "\nEndMessage\n";
+  }
+
+  stream += "AllData\n"
+            "Identifier=ClientGet-1\n"
+            "CompletionTime=1713000000000\n"
+            "StartupTime=1712999999000\n"
+            "DataLength=" +
+            std::to_string(data) +
+            "\n"
+            "Global=false\n"
+            "Metadata.ContentType=application/octet-stream\n"
+            "Data\n";
+  for (std::size_t i = 0; i < data; i++) {
+    stream += static_cast<char>(i * 31);
+  }
+
+  return stream;
+}
+
+/* Split the stream the way Client::Receive does */
+std::vector<Message>
+parse(const std::string& stream)
+{
+  std::vector<Message> messages;
+  std::size_t pos = 0;
+
+  while (pos < stream.size()) {
+    const std::size_t start = pos;
+    for (;;) {
+      const std::size_t end = stream.find('\n', pos);
+      std::string_view line(stream.data() + pos, end - pos);
+      pos = end + 1;
+      if (Message::IsTerminator(line)) {
+        break;
+      }
+    }
+
+    Message message(stream.substr(start, pos - start));
+    if (message.HasData()) {
+      const std::uint64_t length = message.DataLength();
+      message.SetData(stream.substr(pos, length));
+      pos += length;
+    }
+    messages.push_back(std::move(message));
+  }
+
+  return messages;
+}
+
+}
+
+TEST_CASE("protocol::Message parsing", "[protocol::message]")
+{
+  for (std::size_t replies : { 10, 1000 }) {
+    const std::string stream = recorded_stream(replies, 65536);
+    REQUIRE(parse(stream).size() == replies + 2);
+
+    BENCHMARK("NodeHello, " + std::to_string(replies) +
+              " FCPPluginReply, AllData")
+    {
+      return parse(stream);
+    };
+
+    BENCHMARK("NodeHello, " + std::to_string(replies) +
+              " FCPPluginReply, AllData, Identifier lookup")
+    {
+      std::size_t found = 0;
+      for (auto& message : parse(stream)) {
+        found += message.Get("Identifier").has_value();
+      }
+      return found;
+    };
+  }
+}
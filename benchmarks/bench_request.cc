@@ -0,0 +1,81 @@
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <fcp++/protocol/request.hpp>
+
+using fcp::protocol::Request;
+
+TEST_CASE("Request::ToString", "[protocol::request]")
+{
+  BENCHMARK("ClientHello")
+  {
+    return Request::ClientHello("Benchmark").ToRequest().ToString();
+  };
+
+  BENCHMARK("ListPeer")
+  {
+    Request::ListPeer listPeer("0x1234");
+    listPeer.WithMetaData = true;
+    listPeer.WithVolatile = false;
+    return listPeer.ToRequest().ToString();
+  };
+
+  BENCHMARK("ListPeers")
+  {
+    Request::ListPeers listPeers;
+    listPeers.Identifier = "ListPeers-1";
+    listPeers.WithMetaData = true;
+    listPeers.WithVolatile = true;
+    return listPeers.ToRequest().ToString();
+  };
+
+  BENCHMARK("ListPeerNotes")
+  {
+    return Request::ListPeerNotes("0x1234").ToRequest().ToString();
+  };
+
+  BENCHMARK("AddPeer")
+  {
+    Request::AddPeer addPeer;
+    addPeer.File = "/tmp/friend.fref";
+    return addPeer.ToRequest().ToString();
+  };
+
+  BENCHMARK("ModifyPeer")
+  {
+    Request::ModifyPeer modifyPeer("0x1234");
+    modifyPeer.IsDisabled = false;
+    modifyPeer.Trust = fcp::Node::Trust::High;
+    return modifyPeer.ToRequest().ToString();
+  };
+
+  BENCHMARK_ADVANCED("ClientPutComplexDir 10000 files")
+  (Catch::Benchmark::Chronometer meter)
+  {
+    Request::ClientPutComplexDir put("site", "CHK@");
+    for (int i = 0; i < 10000; i++) {
+      put.Files.push_back(
+        { "file" + std::to_string(i) + ".html", "/dev/null", 1024 });
+    }
+
+    meter.measure([&put] { return put.ToHeader(); });
+  };
+
+  BENCHMARK("FCPPluginMessage")
+  {
+    Request::FCPPluginMessage call("plugins.HelloFCP.HelloFCP");
+    call.Identifier = "FCPPluginMessage-1";
+    call.Params["Message"] = "Ping";
+    return call.ToRequest().ToString();
+  };
+
+  BENCHMARK("Disconnect")
+  {
+    return Request::Disconnect().ToRequest().ToString();
+  };
+
+  BENCHMARK("Shutdown")
+  {
+    return Request::Shutdown().ToRequest().ToString();
+  };
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2024 d0p1 <contact@d0p1.eu>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of mosquitto nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef FCP_CACHE_HPP_
+#define FCP_CACHE_HPP_
+
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace fcp {
+
+/**
+ * Size bounded on-disk store for fetched content.
+ *
+ * Only CHK and SSK keys are accepted, their content never changes once
+ * inserted so a hit can be served without asking the node. Entries are
+ * evicted least recently used first; the order survives restarts through
+ * the file modification time. Entries carry their length and checksum, a
+ * truncated or corrupted entry is dropped instead of being served.
+ */
+class Cache
+{
+public:
+  Cache(const std::filesystem::path& directory, std::uintmax_t capacity);
+  virtual ~Cache() = default;
+
+  static bool IsCacheable(std::string_view uri);
+
+  std::optional<std::string> Get(std::string_view uri);
+  bool Put(std::string_view uri, std::string_view data);
+  void Remove(std::string_view uri);
+
+  std::uintmax_t Size() const;
+  std::uintmax_t Capacity() const { return this->mCapacity; }
+
+private:
+  struct Entry
+  {
+    std::string URI;
+    std::uintmax_t Size;
+  };
+
+  std::filesystem::path PathOf(std::string_view uri) const;
+  void Evict(std::uintmax_t needed);
+  void Erase(std::list<Entry>::iterator entry);
+
+  std::filesystem::path mDirectory;
+  std::uintmax_t mCapacity;
+  std::uintmax_t mSize;
+
+  mutable std::mutex mMutex;
+  /** Most recently used entry first */
+  std::list<Entry> mEntries;
+  std::unordered_map<std::string_view, std::list<Entry>::iterator> mIndex;
+};
+
+}
+
+#endif // !FCP_CACHE_HPP_
@@ -30,11 +30,22 @@
 #define FCP_CLIENT_HPP_
 
 #include <boost/asio/io_service.hpp>
+#include <algorithm>
 #include <boost/asio/ip/tcp.hpp>
 #include <fcp++/node.hpp>
+#include <fcp++/protocol/message.hpp>
 #include <fcp++/protocol/request.hpp>
 #include <fcp++/ssk/keypair.hpp>
+#include <fcp++/stats.hpp>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 
@@ -42,6 +53,21 @@ namespace fcp {
 
 const std::string default_host = "127.0.0.1";
 const unsigned short default_port = 9481;
+const std::chrono::milliseconds default_reconnect_delay(100);
+const std::chrono::milliseconds max_reconnect_delay(30000);
+const std::size_t max_write_queue_size = 64 * 1024;
+const std::chrono::milliseconds max_write_queue_delay(5);
+const std::size_t max_requests_in_flight = 256;
+const std::size_t default_peer_window = 64;
+
+/** Replies to a pipelined batch of requests */
+struct BatchReplies
+{
+  /** One entry per request, in order, empty when its reply never came */
+  std::vector<std::optional<protocol::Message>> Replies;
+  /** Why replies are missing, empty when all of them came */
+  std::string Error;
+};
 
 class Client
 {
@@ -49,14 +75,96 @@ public:
   Client(const std::string& name);
   ~Client();
 
+  /**
+   * Open a connection and send ClientHello, followed by any message queued
+   * while disconnected.
+   *
+   * \return 0 on success, boost::asio::error::already_connected if the
+   *         client is connected, the error code of the failure otherwise
+   */
   int Connect(const std::string& host = default_host,
               unsigned short port = default_port);
   int Connect(const boost::asio::ip::tcp::endpoint& endpoint);
+
+  /**
+   * Reconnect helper with backoff: connect again to the last endpoint given
+   * to \ref Connect, waiting twice as long after each failed attempt (capped
+   * to max_reconnect_delay).
+   *
+   * Nothing reconnects on its own: when a read or write fails the socket is
+   * closed, the error is thrown and \ref IsConnected returns false. Replies
+   * pending on the lost connection are dropped and no state is resynced;
+   * the node keeps persistent requests under the client name, callers that
+   * need them list them again.
+   *
+   * \return 0 on success, the error code of the last attempt otherwise,
+   *         boost::asio::error::not_connected if \ref Connect was never
+   *         called, boost::asio::error::already_connected if the client is
+   *         connected
+   */
+  int Reconnect(unsigned int attempts = 5,
+                std::chrono::milliseconds delay = default_reconnect_delay);
   void Disconnect();
 
+  bool IsConnected() const { return this->mSocket.is_open(); }
+
   template<class Data>
   void Send(Data data);
 
+  /**
+   * Queue a message instead of writing it right away. Queued messages go out
+   * together in a single write on \ref Flush, on the next \ref Send or
+   * \ref Await, or when a message is queued while max_write_queue_size bytes
+   * are pending or the oldest one waited max_write_queue_delay.
+   */
+  template<class Data>
+  void Queue(Data data);
+  void Flush();
+
+  /**
+   * Queue a call to a node plugin. An Identifier is generated when the
+   * message has none. Once max_requests_in_flight calls are unanswered,
+   * replies are read before the call is queued.
+   *
+   * \return the Identifier to pass to \ref Await
+   * \throw std::invalid_argument if the Identifier is already pending
+   */
+  std::string CallPlugin(protocol::Request::FCPPluginMessage message);
+
+  /**
+   * Flush the write queue, then read messages until the reply carrying
+   * identifier arrives. Replies to other pending requests are kept for their
+   * own Await, messages nobody waits for are dropped.
+   *
+   * \throw std::runtime_error if no request with this identifier is pending,
+   *        for example because the connection was lost
+   */
+  protocol::Message Await(const std::string& identifier);
+
+  /** Read the next message sent by the node */
+  protocol::Message Receive();
+
+  void PutComplexDir(protocol::Request::ClientPutComplexDir& put);
+
+  /**
+   * Send many AddPeer messages pipelined, with at most window of them
+   * unanswered at any time (a window of 0 is treated as 1). Messages without
+   * an Identifier get a generated one.
+   *
+   * When the connection is lost midway, the replies read so far are still
+   * returned along with the error.
+   *
+   * \return one reply per peer, in the same order: PeerNode on success,
+   *         ProtocolError otherwise
+   * \throw std::invalid_argument before anything is sent if an Identifier
+   *        appears twice or is already pending
+   */
+  BatchReplies AddPeers(std::vector<protocol::Request::AddPeer>& peers,
+                        std::size_t window = default_peer_window);
+  BatchReplies ModifyPeers(
+    std::vector<protocol::Request::ModifyPeer>& peers,
+    std::size_t window = default_peer_window);
+
   std::vector<Node> ListPeer(Node node);
   std::vector<Node> ListPeers();
 
@@ -66,17 +174,125 @@ public:
 
   void Shutdown();
 
+  const Stats& GetStats() const { return this->mStats; }
+
 private:
+  void Write(protocol::Request& req);
+  void Drop();
+  void Enqueue(protocol::Request& req);
+  std::string NextIdentifier(std::string_view prefix);
+  bool IsInUse(const std::string& identifier) const;
+  std::string Track(std::string identifier, std::string_view prefix);
+  void ReceiveReply();
+  void Fill();
+
+  template<class Data>
+  BatchReplies Pipeline(std::vector<Data>& messages,
+                        std::string_view prefix,
+                        std::size_t window);
+
   boost::asio::io_service mIOService;
   boost::asio::ip::tcp::socket mSocket;
-  const std::string& mAppName;
+  const std::string mAppName;
+  std::optional<boost::asio::ip::tcp::endpoint> mEndpoint;
+  Stats mStats;
+
+  std::string mWriteQueue;
+  /** Name and size of every message in mWriteQueue */
+  std::vector<std::pair<std::string_view, std::size_t>> mQueued;
+  std::chrono::steady_clock::time_point mQueuedSince;
+  std::uint64_t mNextIdentifier;
+
+  std::string mReadBuffer;
+  std::size_t mReadOffset;
+  /** Requests waiting for a reply: name and time sent, by Identifier */
+  std::unordered_map<std::string,
+                     std::pair<std::string_view,
+                               std::chrono::steady_clock::time_point>>
+    mPending;
+  std::unordered_map<std::string, protocol::Message> mReplies;
 };
 
 template<class Data>
 void
 Client::Send(Data data)
 {
-  this->mSocket.send(boost::asio::buffer(data.ToRequest().ToString()));
+  protocol::Request req = data.ToRequest();
+
+  this->Flush();
+  this->Write(req);
+}
+
+template<class Data>
+void
+Client::Queue(Data data)
+{
+  protocol::Request req = data.ToRequest();
+
+  this->Enqueue(req);
+}
+
+template<class Data>
+BatchReplies
+Client::Pipeline(std::vector<Data>& messages,
+                 std::string_view prefix,
+                 std::size_t window)
+{
+  window = std::max<std::size_t>(window, 1);
+
+  /* check every Identifier before sending anything, a reply to one of two
+   * requests with the same Identifier could not be told apart */
+  std::unordered_set<std::string> identifiers;
+  for (auto& message : messages) {
+    const std::string identifier = message.Identifier.value_or("");
+    if (identifier.empty()) {
+      continue;
+    }
+    if (this->IsInUse(identifier) || !identifiers.insert(identifier).second) {
+      throw std::invalid_argument("Identifier " + identifier +
+                                  " is already in use");
+    }
+  }
+  for (auto& message : messages) {
+    if (message.Identifier.value_or("").empty()) {
+      std::string identifier;
+      do {
+        identifier = this->NextIdentifier(prefix);
+      } while (identifiers.count(identifier) != 0);
+      message.Identifier = identifier;
+    }
+  }
+
+  BatchReplies batch;
+  batch.Replies.resize(messages.size());
+  try {
+    for (auto& message : messages) {
+      /* read replies as they come so the node never blocks writing them */
+      while (this->mPending.size() >= window) {
+        this->ReceiveReply();
+      }
+
+      this->Track(message.Identifier.value(), prefix);
+      this->Queue(message);
+    }
+
+    for (std::size_t i = 0; i < messages.size(); i++) {
+      batch.Replies[i] = this->Await(messages[i].Identifier.value());
+    }
+  } catch (std::exception& e) {
+    batch.Error = e.what();
+
+    /* keep the replies read before the failure */
+    for (std::size_t i = 0; i < messages.size(); i++) {
+      auto it = this->mReplies.find(messages[i].Identifier.value());
+      if (!batch.Replies[i].has_value() && it != this->mReplies.end()) {
+        batch.Replies[i] = std::move(it->second);
+        this->mReplies.erase(it);
+      }
+    }
+  }
+
+  return batch;
 }
 
 }
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2024 d0p1 <contact@d0p1.eu>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of mosquitto nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef FCP_PROTOCOL_MESSAGE_HPP_
+#define FCP_PROTOCOL_MESSAGE_HPP_
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace fcp::protocol {
+
+/**
+ * A message read from the node.
+ *
+ * The header is kept as received, fields are only offsets into it so looking
+ * them up does not build any map.
+ *
+ * \code{.unparsed}
+ * FCPPluginReply
+ * PluginName=plugins.HelloFCP.HelloFCP
+ * Identifier=FCPPluginMessage-1
+ * Replies.Message=Pong
+ * EndMessage
+ * \endcode
+ */
+class Message
+{
+public:
+  Message() = default;
+
+  /**
+   * Parse a header, from the name line up to and including the "EndMessage"
+   * or "Data" line.
+   */
+  explicit Message(std::string header);
+  virtual ~Message() = default;
+
+  /**
+   * True for the line closing a header, "EndMessage" or "Data", with or
+   * without a trailing '\r'.
+   */
+  static bool IsTerminator(std::string_view line)
+  {
+    if (!line.empty() && line.back() == '\r') {
+      line.remove_suffix(1);
+    }
+    return line == "EndMessage" || line == "Data";
+  }
+
+  std::string_view Name() const { return this->View(this->mName); }
+
+  /** Value of the first field named key */
+  std::optional<std::string_view> Get(std::string_view key) const;
+
+  std::size_t FieldCount() const { return this->mFields.size(); }
+  std::pair<std::string_view, std::string_view> Field(std::size_t i) const
+  {
+    return { this->View(this->mFields[i].first),
+             this->View(this->mFields[i].second) };
+  }
+
+  /** True when the header ends with "Data", DataLength bytes follow it */
+  bool HasData() const { return this->mHasData; }
+  /** Value of DataLength, 0 if absent or invalid */
+  std::uint64_t DataLength() const;
+
+  const std::string& Data() const { return this->mData; }
+  void SetData(std::string aData) { this->mData = std::move(aData); }
+
+  /** Size of the message on the wire */
+  std::size_t Size() const { return this->mHeader.size() + this->mData.size(); }
+
+private:
+  struct Span
+  {
+    std::uint32_t Offset = 0;
+    std::uint32_t Length = 0;
+  };
+
+  std::string_view View(Span span) const
+  {
+    return std::string_view(this->mHeader).substr(span.Offset, span.Length);
+  }
+
+  std::string mHeader;
+  Span mName;
+  std::vector<std::pair<Span, Span>> mFields;
+  bool mHasData = false;
+  std::string mData;
+};
+
+}
+
+#endif // !FCP_PROTOCOL_MESSAGE_HPP_
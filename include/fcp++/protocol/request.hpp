@@ -30,11 +30,15 @@
 #define FCP_REQUEST_HPP_
 
 #include <boost/asio/ip/tcp.hpp>
+#include <charconv>
+#include <cstdint>
 #include <fcp++/node.hpp>
+#include <filesystem>
 #include <optional>
 #include <string>
 #include <string_view>
 #include <unordered_map>
+#include <vector>
 
 namespace fcp::protocol {
 
@@ -52,9 +56,31 @@ public:
     this->mAttributes[aKey] = aValue;
   };
 
+  /**
+   * Attach a payload, the message is then terminated by "Data" instead of
+   * "EndMessage" and followed by the raw bytes.
+   */
+  void SetData(std::string aData)
+  {
+    this->SetAttribute("DataLength", std::to_string(aData.size()));
+    this->mData = std::move(aData);
+  }
+
+  std::string_view Name() const { return this->mName; }
+
   std::string ToString()
   {
-    std::string str(this->mName);
+    std::size_t size = this->mName.size() + sizeof("\nEndMessage\n");
+    if (this->mData.has_value()) {
+      size += this->mData->size();
+    }
+    for (auto& it : this->mAttributes) {
+      size += it.first.size() + it.second.size() + 2;
+    }
+
+    std::string str;
+    str.reserve(size);
+    str += this->mName;
     str += "\n";
     for (auto& it : this->mAttributes) {
       str += it.first;
@@ -62,7 +88,12 @@ public:
       str += it.second;
       str += "\n";
     }
-    str += "EndMessage\n";
+    if (this->mData.has_value()) {
+      str += "Data\n";
+      str += this->mData.value();
+    } else {
+      str += "EndMessage\n";
+    }
 
     return str;
   }
@@ -70,6 +101,7 @@ public:
 private:
   std::string_view mName;
   std::unordered_map<std::string, std::string> mAttributes;
+  std::optional<std::string> mData;
 
 
 public:
@@ -171,7 +203,7 @@ struct ListPeerNotes
   {
   }
 
-  Request ToReq()
+  Request ToRequest()
   {
     Request req("ListPeerNotes");
 
@@ -181,23 +213,156 @@ struct ListPeerNotes
   }
 };
 
+/**
+ * Add a peer from a noderef, either read by the node from File or URL, or
+ * given inline. Node will response with \ref Response::PeerNode or
+ * \ref Response::Type::ProtocolError.
+ *
+ * \code{.unparsed}
+ * AddPeer
+ * Trust=NORMAL
+ * Visibility=NAME_ONLY
+ * File=/home/me/noderefs/friend.fref
+ * EndMessage
+ * \endcode
+ */
 struct AddPeer
 {
-  Node::Trust Trust;
-  Node::Visibility Visibility;
+  /** Echoed in the reply, set by \ref Client::AddPeers when empty */
+  std::optional<std::string> Identifier;
+  Node::Trust Trust = Node::Trust::Normal;
+  Node::Visibility Visibility = Node::Visibility::NameOnly;
+  std::optional<std::string> File;
+  std::optional<std::string> URL;
+  /** Inline noderef fields, sent as is */
+  std::vector<std::pair<std::string, std::string>> NodeRef;
+
+  /**
+   * Build an AddPeer from the text of a noderef ("key=value" lines, up to
+   * "End").
+   */
+  static AddPeer FromNodeRef(std::string_view noderef)
+  {
+    AddPeer peer;
+
+    while (!noderef.empty()) {
+      std::size_t end = noderef.find('\n');
+      std::string_view line = noderef.substr(0, end);
+      noderef.remove_prefix(end == std::string_view::npos ? noderef.size()
+                                                           : end + 1);
+
+      if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
+      }
+      if (line == "End" || line == "EndMessage") {
+        break;
+      }
+
+      std::size_t sep = line.find('=');
+      if (sep == std::string_view::npos) {
+        continue;
+      }
+      peer.NodeRef.emplace_back(line.substr(0, sep), line.substr(sep + 1));
+    }
 
-  Request ToReq()
+    return peer;
+  }
+
+  Request ToRequest()
   {
     Request req("AddPeer");
+    if (this->Identifier.has_value()) {
+      req.SetAttribute("Identifier", this->Identifier.value());
+    }
     req.SetAttribute("Trust", to_string(this->Trust));
     req.SetAttribute("Visibility", to_string(this->Visibility));
+    if (this->File.has_value()) {
+      req.SetAttribute("File", this->File.value());
+    }
+
+    if (this->URL.has_value()) {
+      req.SetAttribute("URL", this->URL.value());
+    }
+
+    for (auto& it : this->NodeRef) {
+      req.SetAttribute(it.first, it.second);
+    }
 
     return req;
   }
 };
 
+/**
+ * Change the settings of an existing peer, answered by
+ * \ref Response::PeerNode.
+ *
+ * \code{.unparsed}
+ * ModifyPeer
+ * NodeIdentifier=Darknet_Node1
+ * IsDisabled=false
+ * EndMessage
+ * \endcode
+ */
 struct ModifyPeer
-{};
+{
+  /** Echoed in the reply, set by \ref Client::ModifyPeers when empty */
+  std::optional<std::string> Identifier;
+  std::string NodeIdentifier;
+  std::optional<bool> AllowLocalAddresses;
+  std::optional<bool> IsDisabled;
+  std::optional<bool> IsListenOnly;
+  std::optional<bool> IsBurstOnly;
+  std::optional<bool> IgnoreSourcePort;
+  std::optional<Node::Trust> Trust;
+  std::optional<Node::Visibility> Visibility;
+
+  ModifyPeer(std::string_view ident)
+    : NodeIdentifier(ident)
+  {
+  }
+
+  Request ToRequest()
+  {
+    Request req("ModifyPeer");
+
+    req.SetAttribute("NodeIdentifier", this->NodeIdentifier);
+    if (this->Identifier.has_value()) {
+      req.SetAttribute("Identifier", this->Identifier.value());
+    }
+
+    if (this->AllowLocalAddresses.has_value()) {
+      req.SetAttribute("AllowLocalAddresses",
+                       to_string(this->AllowLocalAddresses.value()));
+    }
+
+    if (this->IsDisabled.has_value()) {
+      req.SetAttribute("IsDisabled", to_string(this->IsDisabled.value()));
+    }
+
+    if (this->IsListenOnly.has_value()) {
+      req.SetAttribute("IsListenOnly", to_string(this->IsListenOnly.value()));
+    }
+
+    if (this->IsBurstOnly.has_value()) {
+      req.SetAttribute("IsBurstOnly", to_string(this->IsBurstOnly.value()));
+    }
+
+    if (this->IgnoreSourcePort.has_value()) {
+      req.SetAttribute("IgnoreSourcePort",
+                       to_string(this->IgnoreSourcePort.value()));
+    }
+
+    if (this->Trust.has_value()) {
+      req.SetAttribute("Trust", to_string(this->Trust.value()));
+    }
+
+    if (this->Visibility.has_value()) {
+      req.SetAttribute("Visibility", to_string(this->Visibility.value()));
+    }
+
+    return req;
+  }
+};
 
 struct Disconnect
 {
@@ -217,6 +382,195 @@ struct Shutdown
   Request ToRequest() { return Request("Shutdown"); }
 };
 
+/**
+ * Insert a whole directory as a single manifest. Every file is sent inline
+ * (UploadFrom=direct), their content follows EndMessage in the same order as
+ * the Files.N fields. It can only be sent with \ref Client::PutComplexDir,
+ * which streams the payload after the header; there is no ToRequest() so
+ * Client::Send and Client::Queue reject it at compile time.
+ *
+ * \code{.unparsed}
+ * ClientPutComplexDir
+ * Identifier=My Site
+ * URI=CHK@
+ * DefaultName=index.html
+ * Files.0.Name=index.html
+ * Files.0.UploadFrom=direct
+ * Files.0.DataLength=1234
+ * EndMessage
+ * <1234 bytes of data>
+ * \endcode
+ */
+struct ClientPutComplexDir
+{
+  struct File
+  {
+    /** Name of the file inside the manifest */
+    std::string Name;
+    /** Where to read the content from on the local disk */
+    std::filesystem::path Path;
+    std::uintmax_t DataLength;
+  };
+
+  std::string Identifier;
+  std::string URI;
+  std::optional<std::string> DefaultName;
+  std::optional<bool> Global;
+  std::vector<File> Files;
+
+  ClientPutComplexDir(std::string_view ident, std::string_view uri)
+    : Identifier(ident)
+    , URI(uri)
+  {
+  }
+
+  /**
+   * Add every regular file found below directory, sizes are taken now so the
+   * whole message length is known before anything is sent.
+   */
+  void AddDirectory(const std::filesystem::path& directory)
+  {
+    for (auto& entry :
+         std::filesystem::recursive_directory_iterator(directory)) {
+      if (!entry.is_regular_file()) {
+        continue;
+      }
+
+      this->Files.push_back(
+        File{ entry.path().lexically_relative(directory).generic_string(),
+              entry.path(),
+              entry.file_size() });
+    }
+  }
+
+  /** Total length of the data following EndMessage */
+  std::uintmax_t DataLength() const
+  {
+    std::uintmax_t total = 0;
+    for (auto& file : this->Files) {
+      total += file.DataLength;
+    }
+    return total;
+  }
+
+  /**
+   * Header of the message, without the payload. The Files.N fields are
+   * written in index order straight into a string sized up front, a site
+   * with tens of thousands of files does not go through \ref Request.
+   */
+  std::string ToHeader()
+  {
+    Request req("ClientPutComplexDir");
+
+    req.SetAttribute("Identifier", this->Identifier);
+    req.SetAttribute("URI", this->URI);
+    if (this->DefaultName.has_value()) {
+      req.SetAttribute("DefaultName", this->DefaultName.value());
+    }
+
+    if (this->Global.has_value()) {
+      req.SetAttribute("Global", to_string(this->Global.value()));
+    }
+
+    const std::string_view end = "EndMessage\n";
+    std::string fixed = req.ToString();
+    fixed.resize(fixed.size() - end.size());
+
+    std::size_t size = fixed.size() + end.size();
+    for (std::size_t i = 0; i < this->Files.size(); i++) {
+      size += 3 * (sizeof("Files.") - 1 + Digits(i)) +
+              sizeof(".Name=\n") - 1 + this->Files[i].Name.size() +
+              sizeof(".UploadFrom=direct\n") - 1 +
+              sizeof(".DataLength=\n") - 1 + Digits(this->Files[i].DataLength);
+    }
+
+    std::string str;
+    str.reserve(size);
+    str += fixed;
+    for (std::size_t i = 0; i < this->Files.size(); i++) {
+      char index[24];
+      char length[24];
+      const std::string_view n = Format(index, i);
+      const std::string_view len = Format(length, this->Files[i].DataLength);
+
+      str += "Files.";
+      str += n;
+      str += ".Name=";
+      str += this->Files[i].Name;
+      str += "\nFiles.";
+      str += n;
+      str += ".UploadFrom=direct\nFiles.";
+      str += n;
+      str += ".DataLength=";
+      str += len;
+      str += "\n";
+    }
+    str += end;
+
+    return str;
+  }
+
+private:
+  static std::string_view Format(char (&buffer)[24], std::uintmax_t value)
+  {
+    return std::string_view(
+      buffer, std::to_chars(buffer, buffer + sizeof(buffer), value).ptr - buffer);
+  }
+
+  static std::size_t Digits(std::uintmax_t value)
+  {
+    std::size_t digits = 1;
+    while (value >= 10) {
+      value /= 10;
+      digits++;
+    }
+    return digits;
+  }
+};
+
+/**
+ * Message to a plugin loaded on the node, answered by
+ * \ref Response::Type::FCPPluginReply with the same Identifier.
+ *
+ * \code{.unparsed}
+ * FCPPluginMessage
+ * PluginName=plugins.HelloFCP.HelloFCP
+ * Identifier=FCPPluginMessage-1
+ * Param.Message=Ping
+ * EndMessage
+ * \endcode
+ */
+struct FCPPluginMessage
+{
+  std::string PluginName;
+  std::string Identifier;
+  /** Sent as Param.<key>=<value> */
+  std::unordered_map<std::string, std::string> Params;
+  std::optional<std::string> Data;
+
+  FCPPluginMessage(std::string_view plugin)
+    : PluginName(plugin)
+  {
+  }
+
+  Request ToRequest()
+  {
+    Request req("FCPPluginMessage");
+
+    req.SetAttribute("PluginName", this->PluginName);
+    req.SetAttribute("Identifier", this->Identifier);
+    for (auto& it : this->Params) {
+      req.SetAttribute("Param." + it.first, it.second);
+    }
+
+    if (this->Data.has_value()) {
+      req.SetData(this->Data.value());
+    }
+
+    return req;
+  }
+};
+
 struct Probe
 {
   enum class Type {
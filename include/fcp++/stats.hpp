@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2024 d0p1 <contact@d0p1.eu>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of mosquitto nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef FCP_STATS_HPP_
+#define FCP_STATS_HPP_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+namespace fcp {
+
+/**
+ * Message counters kept by \ref Client.
+ *
+ * Every message written to or read from the node is counted per message name
+ * along with its size. Latencies go to fixed bucket histograms: one sample
+ * per socket write, and for requests sent with an Identifier the time from
+ * sending them to their reply.
+ */
+class Stats
+{
+public:
+  /** Upper bounds, in microseconds, of the latency histogram buckets */
+  static constexpr std::array<std::uint64_t, 12> latency_buckets = {
+    10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 100000
+  };
+
+  struct Counter
+  {
+    std::uint64_t Messages = 0;
+    std::uint64_t Bytes = 0;
+  };
+
+  struct Histogram
+  {
+    /** Per bucket counts, the last one holds everything above the last bound */
+    std::array<std::uint64_t, latency_buckets.size() + 1> Buckets{};
+    /** Sum of all recorded latencies, in microseconds */
+    std::uint64_t Sum = 0;
+    std::uint64_t Count = 0;
+
+    void Record(std::chrono::nanoseconds latency);
+  };
+
+  struct Snapshot
+  {
+    std::map<std::string, Counter, std::less<>> Sent;
+    std::map<std::string, Counter, std::less<>> Received;
+    /** Time spent in each write to the socket */
+    Histogram Writes;
+    /** Time from sending a request to its reply, per request name */
+    std::map<std::string, Histogram, std::less<>> Completion;
+    std::uint64_t WritesInProgress = 0;
+    std::uint64_t WriteQueueDepth = 0;
+    /** Requests sent with an Identifier and still waiting for their reply */
+    std::uint64_t RequestsInFlight = 0;
+  };
+
+  /**
+   * Keeps the writes in progress gauge up while a socket write is blocked.
+   */
+  class Writing
+  {
+  public:
+    Writing(Stats& stats)
+      : mStats(stats)
+    {
+      mStats.mWritesInProgress.fetch_add(1, std::memory_order_relaxed);
+    }
+    ~Writing()
+    {
+      mStats.mWritesInProgress.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    Writing(const Writing&) = delete;
+    Writing& operator=(const Writing&) = delete;
+
+  private:
+    Stats& mStats;
+  };
+
+  void RecordSent(std::string_view name, std::size_t bytes);
+  void RecordReceived(std::string_view name, std::size_t bytes);
+  void RecordWrite(std::chrono::nanoseconds latency);
+  void RecordCompleted(std::string_view name, std::chrono::nanoseconds latency);
+
+  void SetWriteQueueDepth(std::uint64_t depth)
+  {
+    this->mWriteQueueDepth.store(depth, std::memory_order_relaxed);
+  }
+
+  void SetRequestsInFlight(std::uint64_t count)
+  {
+    this->mRequestsInFlight.store(count, std::memory_order_relaxed);
+  }
+
+  Snapshot GetSnapshot() const;
+
+  /**
+   * Dump counters in the Prometheus text exposition format.
+   *
+   * \code{.unparsed}
+   * # TYPE fcp_messages_sent_total counter
+   * fcp_messages_sent_total{message="ClientHello"} 1
+   * \endcode
+   */
+  std::string ToPrometheus() const;
+
+  void Reset();
+
+private:
+  mutable std::mutex mMutex;
+  std::map<std::string, Counter, std::less<>> mSent;
+  std::map<std::string, Counter, std::less<>> mReceived;
+  Histogram mWrites;
+  std::map<std::string, Histogram, std::less<>> mCompletion;
+  std::atomic<std::uint64_t> mWritesInProgress{ 0 };
+  std::atomic<std::uint64_t> mWriteQueueDepth{ 0 };
+  std::atomic<std::uint64_t> mRequestsInFlight{ 0 };
+};
+
+}
+
+#endif // !FCP_STATS_HPP_
@@ -0,0 +1,303 @@
+/*
+ * Copyright (c) 2024 d0p1 <contact@d0p1.eu>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of mosquitto nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <fcp++/cache.hpp>
+#include <fstream>
+#include <vector>
+
+using namespace fcp;
+namespace fs = std::filesystem;
+
+/*
+ * Each entry is stored in its own file, named after the hash of the URI. The
+ * file starts with the URI on its own line, then the content length and its
+ * checksum on a second line, followed by the raw content:
+ *
+ *   CHK@...\n
+ *   <length> <checksum>\n
+ *   <data>
+ *
+ * Entries are written to a temporary file first and renamed into place.
+ */
+
+namespace {
+
+const char* const temp_suffix = ".tmp";
+
+/* FNV-1a, stable across compilers unlike std::hash */
+std::uint64_t
+fnv1a(std::string_view data)
+{
+  std::uint64_t hash = 0xcbf29ce484222325ULL;
+
+  for (unsigned char c : data) {
+    hash ^= c;
+    hash *= 0x100000001b3ULL;
+  }
+
+  return hash;
+}
+
+bool
+read_header(std::istream& stream,
+            std::string& uri,
+            std::uintmax_t& length,
+            std::uint64_t& checksum)
+{
+  std::string line;
+  unsigned long long len;
+  unsigned long long sum;
+
+  if (!std::getline(stream, uri) || !std::getline(stream, line) ||
+      std::sscanf(line.c_str(), "%llu %llx", &len, &sum) != 2) {
+    return false;
+  }
+
+  length = len;
+  checksum = sum;
+  return true;
+}
+
+std::string
+make_header(std::string_view uri, std::string_view data)
+{
+  char line[64];
+
+  std::snprintf(line,
+                sizeof(line),
+                "%llu %016llx\n",
+                static_cast<unsigned long long>(data.size()),
+                static_cast<unsigned long long>(fnv1a(data)));
+
+  return std::string(uri) + "\n" + line;
+}
+
+}
+
+Cache::Cache(const fs::path& directory, std::uintmax_t capacity)
+  : mDirectory(directory)
+  , mCapacity(capacity)
+  , mSize(0)
+{
+  fs::create_directories(this->mDirectory);
+
+  /* anything that is not a complete entry is removed so it cannot leak */
+  std::vector<std::pair<fs::file_time_type, Entry>> found;
+  for (auto& file : fs::directory_iterator(this->mDirectory)) {
+    if (!file.is_regular_file()) {
+      continue;
+    }
+
+    std::string uri;
+    std::uintmax_t length;
+    std::uint64_t checksum;
+    std::uintmax_t header_size;
+    bool valid;
+    {
+      std::ifstream stream(file.path(), std::ios::binary);
+      valid = read_header(stream, uri, length, checksum);
+      header_size = valid ? static_cast<std::uintmax_t>(stream.tellg()) : 0;
+    }
+
+    if (!valid || this->PathOf(uri) != file.path() ||
+        file.file_size() != header_size + length) {
+      std::error_code ec;
+      fs::remove(file.path(), ec);
+      continue;
+    }
+
+    found.push_back({ file.last_write_time(), Entry{ uri, length } });
+  }
+
+  std::sort(found.begin(), found.end(), [](auto& a, auto& b) {
+    return a.first > b.first;
+  });
+
+  for (auto& it : found) {
+    this->mSize += it.second.Size;
+    this->mEntries.push_back(std::move(it.second));
+    this->mIndex[this->mEntries.back().URI] = std::prev(this->mEntries.end());
+  }
+
+  std::lock_guard<std::mutex> lock(this->mMutex);
+  this->Evict(0);
+}
+
+bool
+Cache::IsCacheable(std::string_view uri)
+{
+  if (uri.find('\n') != std::string_view::npos) {
+    return false;
+  }
+
+  return uri.starts_with("CHK@") || uri.starts_with("SSK@");
+}
+
+std::optional<std::string>
+Cache::Get(std::string_view uri)
+{
+  std::lock_guard<std::mutex> lock(this->mMutex);
+
+  auto it = this->mIndex.find(uri);
+  if (it == this->mIndex.end()) {
+    return std::nullopt;
+  }
+
+  const fs::path path = this->PathOf(uri);
+  std::ifstream stream(path, std::ios::binary);
+
+  std::string stored;
+  std::uintmax_t length;
+  std::uint64_t checksum;
+  if (read_header(stream, stored, length, checksum) && stored != uri) {
+    /* another URI hashing to the same name replaced our file */
+    this->mSize -= it->second->Size;
+    this->mEntries.erase(it->second);
+    this->mIndex.erase(it);
+    return std::nullopt;
+  }
+
+  std::string data(it->second->Size, '\0');
+  const bool valid = stream && length == data.size() &&
+                     stream.read(data.data(), data.size()) &&
+                     fnv1a(data) == checksum;
+
+  /* Windows refuses to remove a file that is still open */
+  stream.close();
+  if (!valid) {
+    this->Erase(it->second);
+    return std::nullopt;
+  }
+
+  this->mEntries.splice(this->mEntries.begin(), this->mEntries, it->second);
+
+  std::error_code ec;
+  fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+
+  return data;
+}
+
+bool
+Cache::Put(std::string_view uri, std::string_view data)
+{
+  if (!IsCacheable(uri) || data.size() > this->mCapacity) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(this->mMutex);
+
+  auto it = this->mIndex.find(uri);
+  if (it != this->mIndex.end()) {
+    this->Erase(it->second);
+  }
+
+  this->Evict(data.size());
+
+  const fs::path path = this->PathOf(uri);
+  fs::path temp = path;
+  temp += temp_suffix;
+  {
+    const std::string header = make_header(uri, data);
+    std::ofstream stream(temp, std::ios::binary | std::ios::trunc);
+    stream.write(header.data(), header.size());
+    stream.write(data.data(), data.size());
+    stream.close();
+    if (!stream) {
+      std::error_code ec;
+      fs::remove(temp, ec);
+      return false;
+    }
+  }
+
+  std::error_code ec;
+  fs::rename(temp, path, ec);
+  if (ec) {
+    fs::remove(temp, ec);
+    return false;
+  }
+
+  this->mEntries.push_front(Entry{ std::string(uri), data.size() });
+  this->mIndex[this->mEntries.front().URI] = this->mEntries.begin();
+  this->mSize += data.size();
+
+  return true;
+}
+
+void
+Cache::Remove(std::string_view uri)
+{
+  std::lock_guard<std::mutex> lock(this->mMutex);
+
+  auto it = this->mIndex.find(uri);
+  if (it != this->mIndex.end()) {
+    this->Erase(it->second);
+  }
+}
+
+std::uintmax_t
+Cache::Size() const
+{
+  std::lock_guard<std::mutex> lock(this->mMutex);
+
+  return this->mSize;
+}
+
+fs::path
+Cache::PathOf(std::string_view uri) const
+{
+  char name[17];
+
+  std::snprintf(name,
+                sizeof(name),
+                "%016llx",
+                static_cast<unsigned long long>(fnv1a(uri)));
+
+  return this->mDirectory / name;
+}
+
+void
+Cache::Evict(std::uintmax_t needed)
+{
+  while (!this->mEntries.empty() && this->mSize + needed > this->mCapacity) {
+    this->Erase(std::prev(this->mEntries.end()));
+  }
+}
+
+void
+Cache::Erase(std::list<Entry>::iterator entry)
+{
+  std::error_code ec;
+  fs::remove(this->PathOf(entry->URI), ec);
+
+  this->mSize -= entry->Size;
+  this->mIndex.erase(entry->URI);
+  this->mEntries.erase(entry);
+}
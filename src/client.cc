@@ -30,23 +30,197 @@
 #include <boost/asio/buffer.hpp>
 #include <boost/asio/ip/address.hpp>
 #include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/write.hpp>
+#include <fcp++/protocol/message.hpp>
 #include <fcp++/client.hpp>
 #include <fcp++/protocol/request.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <fstream>
 #include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
 
 using namespace fcp;
 using boost_ipaddr = boost::asio::ip::address;
 using boost_tcp = boost::asio::ip::tcp;
 
+namespace {
+
+const std::size_t put_chunk_size = 64 * 1024;
+const std::size_t read_chunk_size = 64 * 1024;
+
+/*
+ * Read the files of a ClientPutComplexDir one after the other as a single
+ * stream, exactly DataLength bytes each.
+ */
+class FileStream
+{
+public:
+  FileStream(const std::vector<protocol::Request::ClientPutComplexDir::File>& files)
+    : mFiles(files)
+    , mIndex(0)
+    , mRemaining(0)
+  {
+  }
+
+  std::size_t Read(char* buffer, std::size_t size)
+  {
+    std::size_t total = 0;
+
+    while (total < size) {
+      if (this->mRemaining == 0) {
+        if (this->mIndex >= this->mFiles.size()) {
+          break;
+        }
+        auto& file = this->mFiles[this->mIndex++];
+        this->mStream = std::ifstream(file.Path, std::ios::binary);
+        this->mRemaining = file.DataLength;
+        continue;
+      }
+
+      const std::size_t count =
+        std::min<std::uintmax_t>(size - total, this->mRemaining);
+      if (!this->mStream.read(buffer + total, count)) {
+        throw std::runtime_error("short read on " +
+                                 this->mFiles[this->mIndex - 1].Path.string());
+      }
+      total += count;
+      this->mRemaining -= count;
+    }
+
+    return total;
+  }
+
+private:
+  const std::vector<protocol::Request::ClientPutComplexDir::File>& mFiles;
+  std::size_t mIndex;
+  std::uintmax_t mRemaining;
+  std::ifstream mStream;
+};
+
+/*
+ * Fill two buffers from a FileStream on a single reader thread, so files are
+ * opened and read while the previous chunk is being written to the socket.
+ */
+class Prefetcher
+{
+public:
+  Prefetcher(const std::vector<protocol::Request::ClientPutComplexDir::File>& files)
+    : mStream(files)
+    , mStop(false)
+    , mThread(&Prefetcher::Run, this)
+  {
+  }
+
+  ~Prefetcher()
+  {
+    {
+      std::lock_guard<std::mutex> lock(this->mMutex);
+      this->mStop = true;
+    }
+    this->mCondition.notify_all();
+    this->mThread.join();
+  }
+
+  Prefetcher(const Prefetcher&) = delete;
+  Prefetcher& operator=(const Prefetcher&) = delete;
+
+  /**
+   * Wait for the next chunk, an empty buffer marks the end of the stream.
+   * The chunk stays valid until the next call.
+   */
+  boost::asio::const_buffer Next()
+  {
+    std::unique_lock<std::mutex> lock(this->mMutex);
+
+    if (this->mCurrent >= 0) {
+      this->mSlots[this->mCurrent].Full = false;
+      this->mCondition.notify_all();
+    }
+    this->mCurrent = (this->mCurrent + 1) % 2;
+
+    Slot& slot = this->mSlots[this->mCurrent];
+    this->mCondition.wait(lock, [&slot] { return slot.Full; });
+    if (this->mError) {
+      std::rethrow_exception(this->mError);
+    }
+
+    return boost::asio::buffer(slot.Data.data(), slot.Size);
+  }
+
+private:
+  struct Slot
+  {
+    std::vector<char> Data = std::vector<char>(put_chunk_size);
+    std::size_t Size = 0;
+    bool Full = false;
+  };
+
+  void Run()
+  {
+    for (int i = 0;; i = (i + 1) % 2) {
+      Slot& slot = this->mSlots[i];
+      {
+        std::unique_lock<std::mutex> lock(this->mMutex);
+        this->mCondition.wait(lock,
+                              [&] { return this->mStop || !slot.Full; });
+        if (this->mStop) {
+          return;
+        }
+      }
+
+      std::size_t size = 0;
+      std::exception_ptr error;
+      try {
+        size = this->mStream.Read(slot.Data.data(), slot.Data.size());
+      } catch (...) {
+        error = std::current_exception();
+      }
+
+      {
+        std::lock_guard<std::mutex> lock(this->mMutex);
+        slot.Size = size;
+        slot.Full = true;
+        this->mError = error;
+      }
+      this->mCondition.notify_all();
+
+      if (size == 0 || error) {
+        return;
+      }
+    }
+  }
+
+  FileStream mStream;
+  Slot mSlots[2];
+  int mCurrent = -1;
+  std::exception_ptr mError;
+  bool mStop;
+  std::mutex mMutex;
+  std::condition_variable mCondition;
+  std::thread mThread;
+};
+
+}
+
 Client::Client(const std::string& name)
-  : mAppName(name)
-  , mSocket(mIOService)
+  : mSocket(mIOService)
+  , mAppName(name)
+  , mNextIdentifier(0)
+  , mReadOffset(0)
 {
 }
 
 Client::~Client()
 {
-  this->Disconnect();
+  try {
+    this->Disconnect();
+  } catch (boost::system::system_error& e) {
+    std::cerr << e.what() << std::endl;
+  }
 }
 
 int
@@ -58,28 +232,351 @@ Client::Connect(const std::string& host, unsigned short port)
 int
 Client::Connect(const boost_tcp::endpoint& endpoint)
 {
+  if (this->IsConnected()) {
+    return boost::asio::error::already_connected;
+  }
+
+  this->mEndpoint = endpoint;
+
   try {
     mSocket.open(endpoint.protocol());
 
     mSocket.connect(endpoint);
 
-    protocol::Request::ClientHello clientHello(this->mAppName);
+    protocol::Request req =
+      protocol::Request::ClientHello(this->mAppName).ToRequest();
 
-    this->Send(clientHello);
+    /* messages queued while disconnected must follow ClientHello */
+    this->Write(req);
+    this->Flush();
   } catch (boost::system::system_error& e) {
     std::cerr << e.what() << std::endl;
+
+    /* keep what was queued for the next attempt */
+    boost::system::error_code ec;
+    mSocket.close(ec);
     return e.code().value();
   }
 
   return 0;
 }
 
+int
+Client::Reconnect(unsigned int attempts, std::chrono::milliseconds delay)
+{
+  if (!this->mEndpoint.has_value()) {
+    return boost::asio::error::not_connected;
+  }
+  if (this->IsConnected()) {
+    return boost::asio::error::already_connected;
+  }
+
+  const boost_tcp::endpoint endpoint = this->mEndpoint.value();
+  int err = this->Connect(endpoint);
+
+  for (unsigned int i = 1; err != 0 && i < attempts; i++) {
+    std::this_thread::sleep_for(delay);
+    delay = std::min(delay * 2, max_reconnect_delay);
+
+    err = this->Connect(endpoint);
+  }
+
+  return err;
+}
+
+void
+Client::PutComplexDir(protocol::Request::ClientPutComplexDir& put)
+{
+  const std::string header = put.ToHeader();
+
+  this->Flush();
+
+  Stats::Writing writing(this->mStats);
+  const auto start = std::chrono::steady_clock::now();
+  try {
+    Prefetcher prefetcher(put.Files);
+
+    boost::asio::write(this->mSocket, boost::asio::buffer(header));
+    for (;;) {
+      const boost::asio::const_buffer chunk = prefetcher.Next();
+      if (chunk.size() == 0) {
+        break;
+      }
+      boost::asio::write(this->mSocket, chunk);
+    }
+  } catch (...) {
+    /* the node still expects the rest of the payload, resync is impossible */
+    this->Drop();
+    throw;
+  }
+
+  this->mStats.RecordWrite(std::chrono::steady_clock::now() - start);
+  this->mStats.RecordSent("ClientPutComplexDir",
+                          header.size() + put.DataLength());
+}
+
+void
+Client::Write(protocol::Request& req)
+{
+  const std::string message = req.ToString();
+
+  Stats::Writing writing(this->mStats);
+  const auto start = std::chrono::steady_clock::now();
+  try {
+    boost::asio::write(this->mSocket, boost::asio::buffer(message));
+  } catch (boost::system::system_error&) {
+    this->Drop();
+    throw;
+  }
+  this->mStats.RecordWrite(std::chrono::steady_clock::now() - start);
+  this->mStats.RecordSent(req.Name(), message.size());
+}
+
+void
+Client::Enqueue(protocol::Request& req)
+{
+  const std::string message = req.ToString();
+  const auto now = std::chrono::steady_clock::now();
+
+  if (this->mQueued.empty()) {
+    this->mQueuedSince = now;
+  }
+  this->mWriteQueue += message;
+  this->mQueued.emplace_back(req.Name(), message.size());
+  this->mStats.SetWriteQueueDepth(this->mQueued.size());
+
+  if (this->mWriteQueue.size() >= max_write_queue_size ||
+      now - this->mQueuedSince >= max_write_queue_delay) {
+    this->Flush();
+  }
+}
+
+void
+Client::Flush()
+{
+  if (this->mQueued.empty() || !mSocket.is_open()) {
+    return;
+  }
+
+  Stats::Writing writing(this->mStats);
+  const auto start = std::chrono::steady_clock::now();
+  try {
+    boost::asio::write(this->mSocket, boost::asio::buffer(this->mWriteQueue));
+  } catch (boost::system::system_error&) {
+    /* part of the queue may have gone out, do not send it twice */
+    this->Drop();
+    throw;
+  }
+  this->mStats.RecordWrite(std::chrono::steady_clock::now() - start);
+
+  for (auto& it : this->mQueued) {
+    this->mStats.RecordSent(it.first, it.second);
+  }
+
+  this->mWriteQueue.clear();
+  this->mQueued.clear();
+  this->mStats.SetWriteQueueDepth(0);
+}
+
+BatchReplies
+Client::AddPeers(std::vector<protocol::Request::AddPeer>& peers,
+                 std::size_t window)
+{
+  return this->Pipeline(peers, "AddPeer", window);
+}
+
+BatchReplies
+Client::ModifyPeers(std::vector<protocol::Request::ModifyPeer>& peers,
+                    std::size_t window)
+{
+  return this->Pipeline(peers, "ModifyPeer", window);
+}
+
+std::string
+Client::CallPlugin(protocol::Request::FCPPluginMessage message)
+{
+  message.Identifier = this->Track(message.Identifier, "FCPPluginMessage");
+
+  this->Queue(message);
+
+  return message.Identifier;
+}
+
+std::string
+Client::NextIdentifier(std::string_view prefix)
+{
+  std::string identifier;
+  do {
+    identifier =
+      std::string(prefix) + "-" + std::to_string(++this->mNextIdentifier);
+  } while (this->IsInUse(identifier));
+
+  return identifier;
+}
+
+bool
+Client::IsInUse(const std::string& identifier) const
+{
+  return this->mPending.count(identifier) != 0 ||
+         this->mReplies.count(identifier) != 0;
+}
+
+std::string
+Client::Track(std::string identifier, std::string_view prefix)
+{
+  if (identifier.empty()) {
+    identifier = this->NextIdentifier(prefix);
+  } else if (this->IsInUse(identifier)) {
+    throw std::invalid_argument("Identifier " + identifier +
+                                " is already in use");
+  }
+
+  while (this->mPending.size() >= max_requests_in_flight) {
+    this->ReceiveReply();
+  }
+
+  this->mPending.emplace(
+    identifier, std::make_pair(prefix, std::chrono::steady_clock::now()));
+  this->mStats.SetRequestsInFlight(this->mPending.size());
+
+  return identifier;
+}
+
+protocol::Message
+Client::Await(const std::string& identifier)
+{
+  for (;;) {
+    auto it = this->mReplies.find(identifier);
+    if (it != this->mReplies.end()) {
+      protocol::Message reply = std::move(it->second);
+      this->mReplies.erase(it);
+      return reply;
+    }
+
+    if (this->mPending.count(identifier) == 0) {
+      throw std::runtime_error("no request pending for " + identifier);
+    }
+
+    this->ReceiveReply();
+  }
+}
+
+void
+Client::ReceiveReply()
+{
+  this->Flush();
+
+  protocol::Message message = this->Receive();
+
+  auto identifier = message.Get("Identifier");
+  if (!identifier.has_value()) {
+    return;
+  }
+
+  auto it = this->mPending.find(std::string(identifier.value()));
+  if (it == this->mPending.end()) {
+    return;
+  }
+
+  this->mStats.RecordCompleted(it->second.first,
+                               std::chrono::steady_clock::now() -
+                                 it->second.second);
+  this->mReplies.emplace(it->first, std::move(message));
+  this->mPending.erase(it);
+  this->mStats.SetRequestsInFlight(this->mPending.size());
+}
+
+protocol::Message
+Client::Receive()
+{
+  try {
+    /* only compact once most of the buffer has been consumed, so a chunk
+     * full of small replies is not moved once per message */
+    if (this->mReadOffset == this->mReadBuffer.size()) {
+      this->mReadBuffer.clear();
+      this->mReadOffset = 0;
+    } else if (this->mReadOffset > this->mReadBuffer.size() / 2) {
+      this->mReadBuffer.erase(0, this->mReadOffset);
+      this->mReadOffset = 0;
+    }
+
+    const std::size_t start = this->mReadOffset;
+    std::size_t pos = start;
+    for (;;) {
+      const std::size_t end = this->mReadBuffer.find('\n', pos);
+      if (end == std::string::npos) {
+        this->Fill();
+        continue;
+      }
+
+      std::string_view line(this->mReadBuffer.data() + pos, end - pos);
+      pos = end + 1;
+      if (protocol::Message::IsTerminator(line)) {
+        break;
+      }
+    }
+
+    protocol::Message message(this->mReadBuffer.substr(start, pos - start));
+    if (message.HasData()) {
+      const std::uint64_t length = message.DataLength();
+      while (this->mReadBuffer.size() - pos < length) {
+        this->Fill();
+      }
+      message.SetData(this->mReadBuffer.substr(pos, length));
+      pos += length;
+    }
+
+    this->mReadOffset = pos;
+    this->mStats.RecordReceived(message.Name(), message.Size());
+    return message;
+  } catch (boost::system::system_error&) {
+    this->Drop();
+    throw;
+  }
+}
+
+void
+Client::Fill()
+{
+  const std::size_t size = this->mReadBuffer.size();
+
+  this->mReadBuffer.resize(size + read_chunk_size);
+  const std::size_t count = this->mSocket.read_some(
+    boost::asio::buffer(this->mReadBuffer.data() + size, read_chunk_size));
+  this->mReadBuffer.resize(size + count);
+}
+
 void
 Client::Disconnect()
 {
+  if (!mSocket.is_open()) {
+    return;
+  }
+
   protocol::Request::Disconnect disconnect;
 
   this->Send(disconnect);
+  this->Drop();
+}
+
+void
+Client::Drop()
+{
+  if (!mSocket.is_open()) {
+    return;
+  }
+
+  boost::system::error_code ec;
+  mSocket.close(ec);
+
+  /* replies to requests sent or queued on this connection will never come */
+  this->mWriteQueue.clear();
+  this->mQueued.clear();
+  this->mStats.SetWriteQueueDepth(0);
+  this->mPending.clear();
+  this->mStats.SetRequestsInFlight(0);
+  this->mReadBuffer.clear();
+  this->mReadOffset = 0;
 }
 
 void
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2024 d0p1 <contact@d0p1.eu>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of mosquitto nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <charconv>
+#include <fcp++/protocol/message.hpp>
+
+using namespace fcp::protocol;
+
+Message::Message(std::string header)
+  : mHeader(std::move(header))
+{
+  std::string_view text(this->mHeader);
+  std::size_t pos = 0;
+  bool first = true;
+
+  while (pos < text.size()) {
+    std::size_t end = text.find('\n', pos);
+    if (end == std::string_view::npos) {
+      end = text.size();
+    }
+    std::string_view line = text.substr(pos, end - pos);
+    const std::uint32_t offset = pos;
+    pos = end + 1;
+
+    if (!line.empty() && line.back() == '\r') {
+      line.remove_suffix(1);
+    }
+
+    if (first) {
+      this->mName = { offset, static_cast<std::uint32_t>(line.size()) };
+      first = false;
+      continue;
+    }
+
+    if (IsTerminator(line)) {
+      this->mHasData = line == "Data";
+      break;
+    }
+
+    const std::size_t sep = line.find('=');
+    if (sep == std::string_view::npos) {
+      continue;
+    }
+    this->mFields.push_back(
+      { { offset, static_cast<std::uint32_t>(sep) },
+        { static_cast<std::uint32_t>(offset + sep + 1),
+          static_cast<std::uint32_t>(line.size() - sep - 1) } });
+  }
+}
+
+std::optional<std::string_view>
+Message::Get(std::string_view key) const
+{
+  for (auto& it : this->mFields) {
+    if (this->View(it.first) == key) {
+      return this->View(it.second);
+    }
+  }
+
+  return std::nullopt;
+}
+
+std::uint64_t
+Message::DataLength() const
+{
+  std::uint64_t length = 0;
+
+  auto value = this->Get("DataLength");
+  if (value.has_value()) {
+    std::from_chars(value->data(), value->data() + value->size(), length);
+  }
+
+  return length;
+}
@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) 2024 d0p1 <contact@d0p1.eu>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of mosquitto nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <fcp++/stats.hpp>
+
+using namespace fcp;
+
+namespace {
+
+template<class Value>
+Value&
+lookup(std::map<std::string, Value, std::less<>>& map, std::string_view name)
+{
+  auto it = map.find(name);
+  if (it == map.end()) {
+    it = map.emplace(std::string(name), Value()).first;
+  }
+  return it->second;
+}
+
+void
+append_counters(std::string& str,
+                const std::string& metric,
+                const std::map<std::string, Stats::Counter, std::less<>>& counters)
+{
+  str += "# TYPE fcp_messages_" + metric + "_total counter\n";
+  for (auto& it : counters) {
+    str += "fcp_messages_" + metric + "_total{message=\"" + it.first + "\"} ";
+    str += std::to_string(it.second.Messages) + "\n";
+  }
+
+  str += "# TYPE fcp_bytes_" + metric + "_total counter\n";
+  for (auto& it : counters) {
+    str += "fcp_bytes_" + metric + "_total{message=\"" + it.first + "\"} ";
+    str += std::to_string(it.second.Bytes) + "\n";
+  }
+}
+
+void
+append_histogram(std::string& str,
+                 const std::string& metric,
+                 const std::string& label,
+                 const Stats::Histogram& histogram)
+{
+  const std::string open = label.empty() ? "{" : "{" + label + ",";
+  const std::string labels = label.empty() ? "" : "{" + label + "}";
+  std::uint64_t cumulative = 0;
+
+  for (std::size_t i = 0; i < Stats::latency_buckets.size(); i++) {
+    cumulative += histogram.Buckets[i];
+    str += metric + "_bucket" + open + "le=\"";
+    str += std::to_string(Stats::latency_buckets[i]) + "\"} ";
+    str += std::to_string(cumulative) + "\n";
+  }
+  str += metric + "_bucket" + open + "le=\"+Inf\"} ";
+  str += std::to_string(histogram.Count) + "\n";
+  str += metric + "_sum" + labels + " " + std::to_string(histogram.Sum) + "\n";
+  str += metric + "_count" + labels + " " + std::to_string(histogram.Count);
+  str += "\n";
+}
+
+}
+
+void
+Stats::Histogram::Record(std::chrono::nanoseconds latency)
+{
+  const std::uint64_t us =
+    std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+  const std::size_t bucket =
+    std::lower_bound(latency_buckets.begin(), latency_buckets.end(), us) -
+    latency_buckets.begin();
+
+  this->Buckets[bucket]++;
+  this->Sum += us;
+  this->Count++;
+}
+
+void
+Stats::RecordSent(std::string_view name, std::size_t bytes)
+{
+  std::lock_guard<std::mutex> lock(this->mMutex);
+
+  Counter& counter = lookup(this->mSent, name);
+  counter.Messages++;
+  counter.Bytes += bytes;
+}
+
+void
+Stats::RecordReceived(std::string_view name, std::size_t bytes)
+{
+  std::lock_guard<std::mutex> lock(this->mMutex);
+
+  Counter& counter = lookup(this->mReceived, name);
+  counter.Messages++;
+  counter.Bytes += bytes;
+}
+
+void
+Stats::RecordWrite(std::chrono::nanoseconds latency)
+{
+  std::lock_guard<std::mutex> lock(this->mMutex);
+
+  this->mWrites.Record(latency);
+}
+
+void
+Stats::RecordCompleted(std::string_view name, std::chrono::nanoseconds latency)
+{
+  std::lock_guard<std::mutex> lock(this->mMutex);
+
+  lookup(this->mCompletion, name).Record(latency);
+}
+
+Stats::Snapshot
+Stats::GetSnapshot() const
+{
+  Snapshot snapshot;
+
+  {
+    std::lock_guard<std::mutex> lock(this->mMutex);
+    snapshot.Sent = this->mSent;
+    snapshot.Received = this->mReceived;
+    snapshot.Writes = this->mWrites;
+    snapshot.Completion = this->mCompletion;
+  }
+  snapshot.WritesInProgress =
+    this->mWritesInProgress.load(std::memory_order_relaxed);
+  snapshot.WriteQueueDepth =
+    this->mWriteQueueDepth.load(std::memory_order_relaxed);
+  snapshot.RequestsInFlight =
+    this->mRequestsInFlight.load(std::memory_order_relaxed);
+
+  return snapshot;
+}
+
+std::string
+Stats::ToPrometheus() const
+{
+  const Snapshot snapshot = this->GetSnapshot();
+  std::string str;
+
+  append_counters(str, "sent", snapshot.Sent);
+  append_counters(str, "received", snapshot.Received);
+
+  str += "# TYPE fcp_write_latency_microseconds histogram\n";
+  append_histogram(str, "fcp_write_latency_microseconds", "", snapshot.Writes);
+
+  str += "# TYPE fcp_request_duration_microseconds histogram\n";
+  for (auto& it : snapshot.Completion) {
+    append_histogram(str,
+                     "fcp_request_duration_microseconds",
+                     "message=\"" + it.first + "\"",
+                     it.second);
+  }
+
+  str += "# TYPE fcp_writes_in_progress gauge\n";
+  str += "fcp_writes_in_progress ";
+  str += std::to_string(snapshot.WritesInProgress) + "\n";
+
+  str += "# TYPE fcp_write_queue_depth gauge\n";
+  str += "fcp_write_queue_depth " + std::to_string(snapshot.WriteQueueDepth);
+  str += "\n";
+
+  str += "# TYPE fcp_requests_in_flight gauge\n";
+  str += "fcp_requests_in_flight " + std::to_string(snapshot.RequestsInFlight);
+  str += "\n";
+
+  return str;
+}
+
+void
+Stats::Reset()
+{
+  std::lock_guard<std::mutex> lock(this->mMutex);
+  this->mSent.clear();
+  this->mReceived.clear();
+  this->mWrites = Histogram();
+  this->mCompletion.clear();
+}
@@ -0,0 +1,112 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <fcp++/cache.hpp>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+static fs::path
+cache_directory(const std::string& name)
+{
+  fs::path path = fs::temp_directory_path() / ("fcp-test-cache-" + name);
+  fs::remove_all(path);
+  return path;
+}
+
+TEST_CASE("only cache immutable keys", "[cache]")
+{
+  REQUIRE(fcp::Cache::IsCacheable("CHK@abc,def,AAMC--8/index.html"));
+  REQUIRE(fcp::Cache::IsCacheable("SSK@abc,def,AQACAAE/site-1/"));
+  REQUIRE_FALSE(fcp::Cache::IsCacheable("USK@abc,def,AQACAAE/site/1/"));
+  REQUIRE_FALSE(fcp::Cache::IsCacheable("KSK@gpl.txt"));
+}
+
+TEST_CASE("store and fetch content", "[cache]")
+{
+  fcp::Cache cache(cache_directory("get"), 1024);
+
+  REQUIRE_FALSE(cache.Get("CHK@a").has_value());
+  REQUIRE(cache.Put("CHK@a", "hello"));
+  REQUIRE(cache.Get("CHK@a") == "hello");
+  REQUIRE(cache.Size() == 5);
+  REQUIRE_FALSE(cache.Put("USK@a/site/1", "hello"));
+}
+
+TEST_CASE("evict least recently used entries", "[cache]")
+{
+  fcp::Cache cache(cache_directory("evict"), 10);
+
+  REQUIRE(cache.Put("CHK@a", "aaaa"));
+  REQUIRE(cache.Put("CHK@b", "bbbb"));
+  REQUIRE(cache.Get("CHK@a").has_value());
+  REQUIRE(cache.Put("CHK@c", "cccc"));
+
+  REQUIRE(cache.Get("CHK@a") == "aaaa");
+  REQUIRE_FALSE(cache.Get("CHK@b").has_value());
+  REQUIRE(cache.Get("CHK@c") == "cccc");
+  REQUIRE(cache.Size() == 8);
+  REQUIRE_FALSE(cache.Put("CHK@d", "way too large"));
+}
+
+TEST_CASE("reload index from disk", "[cache]")
+{
+  const fs::path directory = cache_directory("reload");
+
+  {
+    fcp::Cache cache(directory, 1024);
+    REQUIRE(cache.Put("CHK@a", "persisted"));
+  }
+
+  fcp::Cache cache(directory, 1024);
+  REQUIRE(cache.Size() == 9);
+  REQUIRE(cache.Get("CHK@a") == "persisted");
+}
+
+TEST_CASE("drop truncated entries", "[cache]")
+{
+  const fs::path directory = cache_directory("truncated");
+
+  {
+    fcp::Cache cache(directory, 1024);
+    REQUIRE(cache.Put("CHK@a", "0123456789"));
+  }
+
+  for (auto& file : fs::directory_iterator(directory)) {
+    fs::resize_file(file.path(), fs::file_size(file.path()) - 2);
+  }
+
+  fcp::Cache cache(directory, 1024);
+  REQUIRE(cache.Size() == 0);
+  REQUIRE_FALSE(cache.Get("CHK@a").has_value());
+  REQUIRE(fs::is_empty(directory));
+}
+
+TEST_CASE("drop corrupted entries on read", "[cache]")
+{
+  const fs::path directory = cache_directory("corrupted");
+  fcp::Cache cache(directory, 1024);
+  REQUIRE(cache.Put("CHK@a", "0123456789"));
+
+  for (auto& file : fs::directory_iterator(directory)) {
+    std::fstream stream(file.path(),
+                        std::ios::binary | std::ios::in | std::ios::out);
+    stream.seekp(-1, std::ios::end);
+    stream.put('X');
+  }
+
+  REQUIRE_FALSE(cache.Get("CHK@a").has_value());
+  REQUIRE(cache.Size() == 0);
+  REQUIRE(fs::is_empty(directory));
+}
+
+TEST_CASE("remove unknown files from the cache directory", "[cache]")
+{
+  const fs::path directory = cache_directory("unknown");
+  fs::create_directories(directory);
+  std::ofstream(directory / "0123456789abcdef") << "CHK@a\n1 0\nx";
+  std::ofstream(directory / "leftover.tmp") << "partial";
+
+  fcp::Cache cache(directory, 1024);
+  REQUIRE(fs::is_empty(directory));
+}
@@ -0,0 +1,457 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/read.hpp>
+#include <boost/asio/read_until.hpp>
+#include <boost/asio/write.hpp>
+#include <fcp++/client.hpp>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+using namespace std::chrono_literals;
+using boost_tcp = boost::asio::ip::tcp;
+namespace fs = std::filesystem;
+
+/* accept one connection and return everything received until it closes */
+static std::thread
+record(boost_tcp::acceptor& acceptor, std::string& received)
+{
+  return std::thread([&acceptor, &received] {
+    boost_tcp::socket socket(acceptor.get_executor());
+    acceptor.accept(socket);
+
+    boost::system::error_code ec;
+    boost::asio::read(socket, boost::asio::dynamic_buffer(received), ec);
+  });
+}
+
+TEST_CASE("destroy a client that never connected", "[client]")
+{
+  fcp::Client client("test");
+
+  REQUIRE_FALSE(client.IsConnected());
+  client.Disconnect();
+}
+
+TEST_CASE("reconnect sends ClientHello again", "[client]")
+{
+  boost::asio::io_service service;
+  boost_tcp::acceptor acceptor(
+    service, boost_tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+
+  fcp::Client client("test");
+  REQUIRE(client.Connect(acceptor.local_endpoint()) == 0);
+  client.Disconnect();
+  REQUIRE_FALSE(client.IsConnected());
+
+  REQUIRE(client.Reconnect(1, 1ms) == 0);
+  REQUIRE(client.IsConnected());
+  REQUIRE(client.GetStats().GetSnapshot().Sent.at("ClientHello").Messages ==
+          2);
+}
+
+TEST_CASE("connect refuses a live connection", "[client]")
+{
+  boost::asio::io_service service;
+  boost_tcp::acceptor acceptor(
+    service, boost_tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+
+  fcp::Client client("test");
+  REQUIRE(client.Connect(acceptor.local_endpoint()) == 0);
+  client.CallPlugin(
+    fcp::protocol::Request::FCPPluginMessage("plugins.HelloFCP.HelloFCP"));
+
+  REQUIRE(client.Connect(acceptor.local_endpoint()) ==
+          boost::asio::error::already_connected);
+  REQUIRE(client.Reconnect(1, 1ms) == boost::asio::error::already_connected);
+  REQUIRE(client.IsConnected());
+
+  auto snapshot = client.GetStats().GetSnapshot();
+  REQUIRE(snapshot.WriteQueueDepth == 1);
+  REQUIRE(snapshot.RequestsInFlight == 1);
+}
+
+TEST_CASE("reconnect needs a previous connect", "[client]")
+{
+  fcp::Client client("test");
+
+  REQUIRE(client.Reconnect(1, 1ms) == boost::asio::error::not_connected);
+}
+
+TEST_CASE("a failed write closes the connection", "[client]")
+{
+  boost::asio::io_service service;
+  boost_tcp::acceptor acceptor(
+    service, boost_tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+
+  fcp::Client client("test");
+  REQUIRE(client.Connect(acceptor.local_endpoint()) == 0);
+  {
+    boost_tcp::socket peer(service);
+    acceptor.accept(peer);
+    peer.set_option(boost::asio::socket_base::linger(true, 0));
+  }
+
+  REQUIRE_THROWS_AS(
+    [&client] {
+      for (int i = 0; i < 100; i++) {
+        client.Send(fcp::protocol::Request::ListPeers());
+        std::this_thread::sleep_for(1ms);
+      }
+    }(),
+    boost::system::system_error);
+  REQUIRE_FALSE(client.IsConnected());
+}
+
+TEST_CASE("reconnect gives up after the last attempt", "[client]")
+{
+  /* bound but not listening, so connecting is refused and the port cannot
+   * be picked as our own ephemeral port */
+  boost::asio::io_service service;
+  boost_tcp::socket closed(service);
+  closed.open(boost_tcp::v4());
+  closed.bind(boost_tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+  const boost_tcp::endpoint endpoint = closed.local_endpoint();
+
+  fcp::Client client("test");
+  REQUIRE(client.Connect(endpoint) != 0);
+  REQUIRE(client.Reconnect(3, 1ms) != 0);
+  REQUIRE_FALSE(client.IsConnected());
+}
+
+TEST_CASE("plugin calls are batched until flushed", "[client]")
+{
+  boost::asio::io_service service;
+  boost_tcp::acceptor acceptor(
+    service, boost_tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+
+  fcp::Client client("test");
+  REQUIRE(client.Connect(acceptor.local_endpoint()) == 0);
+
+  fcp::protocol::Request::FCPPluginMessage call("plugins.HelloFCP.HelloFCP");
+  const std::string first = client.CallPlugin(call);
+  const std::string second = client.CallPlugin(call);
+
+  REQUIRE(first != second);
+  REQUIRE(client.GetStats().GetSnapshot().WriteQueueDepth == 2);
+  REQUIRE(client.GetStats().GetSnapshot().Sent.count("FCPPluginMessage") == 0);
+
+  client.Flush();
+
+  auto snapshot = client.GetStats().GetSnapshot();
+  REQUIRE(snapshot.WriteQueueDepth == 0);
+  REQUIRE(snapshot.Sent.at("FCPPluginMessage").Messages == 2);
+}
+
+/* fake node answering every AddPeer with a large PeerNode, or ProtocolError
+ * for File=bad, without ever waiting for the client to read */
+static std::thread
+peer_node(boost_tcp::acceptor& acceptor,
+          std::size_t count,
+          bool hang_up = false)
+{
+  return std::thread([&acceptor, count, hang_up] {
+    boost_tcp::socket socket(acceptor.get_executor());
+    acceptor.accept(socket);
+
+    const std::string noderef(4096, 'x');
+    std::string received;
+    for (std::size_t answered = 0; answered < count;) {
+      const std::size_t n = boost::asio::read_until(
+        socket, boost::asio::dynamic_buffer(received), "EndMessage\n");
+      const std::string message = received.substr(0, n);
+      received.erase(0, n);
+      if (!message.starts_with("AddPeer\n")) {
+        continue;
+      }
+
+      const std::size_t pos = message.find("Identifier=") + 11;
+      const std::string identifier =
+        message.substr(pos, message.find('\n', pos) - pos);
+      std::string reply;
+      if (message.find("File=bad\n") != std::string::npos) {
+        reply = "ProtocolError\nIdentifier=" + identifier + "\nCode=10\n";
+      } else {
+        reply = "PeerNode\nIdentifier=" + identifier + "\nark.pubURI=" +
+                noderef + "\n";
+      }
+      reply += "EndMessage\n";
+      boost::asio::write(socket, boost::asio::buffer(reply));
+      answered++;
+    }
+    if (hang_up) {
+      return;
+    }
+
+    boost::system::error_code ec;
+    boost::asio::read(socket, boost::asio::dynamic_buffer(received), ec);
+  });
+}
+
+TEST_CASE("peers are added pipelined and replies collected", "[client]")
+{
+  const std::size_t count = 2000;
+  const std::size_t window = GENERATE(0, 1, 64);
+
+  boost::asio::io_service service;
+  boost_tcp::acceptor acceptor(
+    service, boost_tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+  std::thread server = peer_node(acceptor, count);
+
+  {
+    fcp::Client client("test");
+    REQUIRE(client.Connect(acceptor.local_endpoint()) == 0);
+
+    std::vector<fcp::protocol::Request::AddPeer> peers(count);
+    for (std::size_t i = 0; i < count; i++) {
+      peers[i].File = i % 100 == 0 ? "bad" : "/tmp/friend.fref";
+    }
+
+    auto batch = client.AddPeers(peers, window);
+
+    REQUIRE(batch.Error.empty());
+    REQUIRE(batch.Replies.size() == count);
+    for (std::size_t i = 0; i < count; i++) {
+      REQUIRE(batch.Replies[i]->Get("Identifier") ==
+              peers[i].Identifier.value());
+      REQUIRE(batch.Replies[i]->Name() ==
+              (i % 100 == 0 ? "ProtocolError" : "PeerNode"));
+    }
+
+    auto snapshot = client.GetStats().GetSnapshot();
+    REQUIRE(snapshot.Sent.at("AddPeer").Messages == count);
+    REQUIRE(snapshot.Received.at("PeerNode").Messages == count - count / 100);
+    REQUIRE(snapshot.Completion.at("AddPeer").Count == count);
+    REQUIRE(snapshot.RequestsInFlight == 0);
+  }
+  server.join();
+}
+
+TEST_CASE("peers added before the connection is lost are returned", "[client]")
+{
+  boost::asio::io_service service;
+  boost_tcp::acceptor acceptor(
+    service, boost_tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+  std::thread server = peer_node(acceptor, 3, true);
+
+  {
+    fcp::Client client("test");
+    REQUIRE(client.Connect(acceptor.local_endpoint()) == 0);
+
+    std::vector<fcp::protocol::Request::AddPeer> peers(5);
+    auto batch = client.AddPeers(peers);
+
+    REQUIRE_FALSE(batch.Error.empty());
+    REQUIRE(batch.Replies.size() == 5);
+    for (std::size_t i = 0; i < 3; i++) {
+      REQUIRE(batch.Replies[i]->Get("Identifier") ==
+              peers[i].Identifier.value());
+    }
+    REQUIRE_FALSE(batch.Replies[3].has_value());
+    REQUIRE_FALSE(batch.Replies[4].has_value());
+    REQUIRE_FALSE(client.IsConnected());
+  }
+  server.join();
+}
+
+TEST_CASE("identifiers already in use are rejected", "[client]")
+{
+  boost::asio::io_service service;
+  boost_tcp::acceptor acceptor(
+    service, boost_tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+
+  fcp::Client client("test");
+  REQUIRE(client.Connect(acceptor.local_endpoint()) == 0);
+
+  fcp::protocol::Request::FCPPluginMessage call("plugins.HelloFCP.HelloFCP");
+  call.Identifier = "AddPeer-1";
+  REQUIRE(client.CallPlugin(call) == "AddPeer-1");
+  REQUIRE_THROWS_AS(client.CallPlugin(call), std::invalid_argument);
+
+  std::vector<fcp::protocol::Request::AddPeer> peers(2);
+  peers[0].Identifier = "friend";
+  peers[1].Identifier = "friend";
+  REQUIRE_THROWS_AS(client.AddPeers(peers), std::invalid_argument);
+  peers[1].Identifier = "AddPeer-1";
+  REQUIRE_THROWS_AS(client.AddPeers(peers), std::invalid_argument);
+  REQUIRE(client.GetStats().GetSnapshot().RequestsInFlight == 1);
+
+  /* generated identifiers skip the ones taken */
+  call.Identifier = "FCPPluginMessage-1";
+  client.CallPlugin(call);
+  call.Identifier.clear();
+  REQUIRE(client.CallPlugin(call) == "FCPPluginMessage-2");
+}
+
+TEST_CASE("directory insert streams every file after the header", "[client]")
+{
+  const fs::path directory = fs::temp_directory_path() / "fcp-test-stream";
+  fs::remove_all(directory);
+  fs::create_directories(directory / "sub");
+  std::string big(200000, '\0');
+  for (std::size_t i = 0; i < big.size(); i++) {
+    big[i] = static_cast<char>(i * 7);
+  }
+  std::ofstream(directory / "index.html") << "<html></html>";
+  std::ofstream(directory / "empty.txt");
+  std::ofstream(directory / "sub" / "big.bin", std::ios::binary) << big;
+
+  boost::asio::io_service service;
+  boost_tcp::acceptor acceptor(
+    service, boost_tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+  std::string received;
+  std::thread server = record(acceptor, received);
+
+  fcp::protocol::Request::ClientPutComplexDir put("site", "CHK@");
+  put.AddDirectory(directory);
+  REQUIRE(put.Files.size() == 3);
+
+  {
+    fcp::Client client("test");
+    REQUIRE(client.Connect(acceptor.local_endpoint()) == 0);
+    client.PutComplexDir(put);
+
+    auto snapshot = client.GetStats().GetSnapshot();
+    REQUIRE(snapshot.Sent.at("ClientPutComplexDir").Bytes ==
+            put.ToHeader().size() + big.size() + 13);
+  }
+  server.join();
+
+  std::string expected = put.ToHeader();
+  for (auto& file : put.Files) {
+    std::ifstream stream(file.Path, std::ios::binary);
+    expected += std::string(std::istreambuf_iterator<char>(stream), {});
+  }
+  expected += "Disconnect\nEndMessage\n";
+
+  const std::size_t hello = received.find("EndMessage\n") + 11;
+  REQUIRE(received.substr(hello) == expected);
+}
+
+TEST_CASE("directory insert closes the connection on a short read",
+          "[client]")
+{
+  const fs::path directory = fs::temp_directory_path() / "fcp-test-short";
+  fs::remove_all(directory);
+  fs::create_directories(directory);
+  std::ofstream(directory / "index.html") << "<html></html>";
+
+  boost::asio::io_service service;
+  boost_tcp::acceptor acceptor(
+    service, boost_tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+  std::string received;
+  std::thread server = record(acceptor, received);
+
+  fcp::protocol::Request::ClientPutComplexDir put("site", "CHK@");
+  put.AddDirectory(directory);
+  fs::resize_file(directory / "index.html", 2);
+
+  fcp::Client client("test");
+  REQUIRE(client.Connect(acceptor.local_endpoint()) == 0);
+  REQUIRE_THROWS(client.PutComplexDir(put));
+  REQUIRE_FALSE(client.IsConnected());
+  server.join();
+}
+
+TEST_CASE("plugin replies are matched by Identifier", "[client]")
+{
+  boost::asio::io_service service;
+  boost_tcp::acceptor acceptor(
+    service, boost_tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+
+  /* answer three calls in reverse order */
+  std::thread server([&acceptor] {
+    boost_tcp::socket socket(acceptor.get_executor());
+    acceptor.accept(socket);
+
+    std::string received;
+    std::vector<std::string> identifiers;
+    while (identifiers.size() < 3) {
+      const std::size_t n = boost::asio::read_until(
+        socket, boost::asio::dynamic_buffer(received), "EndMessage\n");
+      const std::string message = received.substr(0, n);
+      received.erase(0, n);
+
+      const std::size_t pos = message.find("Identifier=");
+      if (message.starts_with("FCPPluginMessage\n") &&
+          pos != std::string::npos) {
+        const std::size_t end = message.find('\n', pos);
+        identifiers.push_back(message.substr(pos + 11, end - pos - 11));
+      }
+    }
+
+    std::string replies = "NodeHello\nFCPVersion=2.0\nEndMessage\n";
+    for (auto it = identifiers.rbegin(); it != identifiers.rend(); it++) {
+      replies += "FCPPluginReply\nIdentifier=" + *it +
+                 "\nReplies.Echo=" + *it + "\nDataLength=3\nData\nabc";
+    }
+    boost::asio::write(socket, boost::asio::buffer(replies));
+
+    boost::system::error_code ec;
+    boost::asio::read(socket, boost::asio::dynamic_buffer(received), ec);
+  });
+
+  {
+    fcp::Client client("test");
+    REQUIRE(client.Connect(acceptor.local_endpoint()) == 0);
+
+    fcp::protocol::Request::FCPPluginMessage call("plugins.HelloFCP.HelloFCP");
+    std::vector<std::string> calls;
+    for (int i = 0; i < 3; i++) {
+      calls.push_back(client.CallPlugin(call));
+    }
+    REQUIRE(client.GetStats().GetSnapshot().RequestsInFlight == 3);
+
+    for (auto& identifier : calls) {
+      auto reply = client.Await(identifier);
+      REQUIRE(reply.Name() == "FCPPluginReply");
+      REQUIRE(reply.Get("Replies.Echo") == identifier);
+      REQUIRE(reply.Data() == "abc");
+    }
+    auto snapshot = client.GetStats().GetSnapshot();
+    REQUIRE(snapshot.RequestsInFlight == 0);
+    REQUIRE(snapshot.Received.at("FCPPluginReply").Messages == 3);
+    REQUIRE(snapshot.Completion.at("FCPPluginMessage").Count == 3);
+    REQUIRE_THROWS_AS(client.Await(calls[0]), std::runtime_error);
+  }
+  server.join();
+}
+
+TEST_CASE("receive a burst of small messages", "[client]")
+{
+  boost::asio::io_service service;
+  boost_tcp::acceptor acceptor(
+    service, boost_tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+
+  std::thread server([&acceptor] {
+    boost_tcp::socket socket(acceptor.get_executor());
+    acceptor.accept(socket);
+
+    std::string burst = "NodeHello\r\nFCPVersion=2.0\r\nEndMessage\r\n";
+    for (int i = 0; i < 1000; i++) {
+      burst += "FCPPluginReply\nIdentifier=call-" + std::to_string(i) +
+               "\nEndMessage\n";
+    }
+    boost::asio::write(socket, boost::asio::buffer(burst));
+
+    std::string received;
+    boost::system::error_code ec;
+    boost::asio::read(socket, boost::asio::dynamic_buffer(received), ec);
+  });
+
+  {
+    fcp::Client client("test");
+    REQUIRE(client.Connect(acceptor.local_endpoint()) == 0);
+
+    auto hello = client.Receive();
+    REQUIRE(hello.Name() == "NodeHello");
+    REQUIRE(hello.Get("FCPVersion") == "2.0");
+    for (int i = 0; i < 1000; i++) {
+      auto reply = client.Receive();
+      REQUIRE(reply.Get("Identifier") == "call-" + std::to_string(i));
+    }
+  }
+  server.join();
+}
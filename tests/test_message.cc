@@ -0,0 +1,42 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <fcp++/protocol/message.hpp>
+
+using fcp::protocol::Message;
+
+TEST_CASE("parse a message header", "[protocol::message]")
+{
+  Message message("FCPPluginReply\n"
+                  "PluginName=plugins.HelloFCP.HelloFCP\n"
+                  "Identifier=call-1\n"
+                  "Replies.Message=a=b\n"
+                  "EndMessage\n");
+
+  REQUIRE(message.Name() == "FCPPluginReply");
+  REQUIRE(message.FieldCount() == 3);
+  REQUIRE(message.Get("Identifier") == "call-1");
+  REQUIRE(message.Get("Replies.Message") == "a=b");
+  REQUIRE_FALSE(message.Get("Missing").has_value());
+  REQUIRE(message.Field(0).first == "PluginName");
+  REQUIRE_FALSE(message.HasData());
+}
+
+TEST_CASE("field views survive copies", "[protocol::message]")
+{
+  Message copy;
+  {
+    Message message("ProtocolError\nCode=8\nEndMessage\n");
+    copy = message;
+  }
+
+  REQUIRE(copy.Name() == "ProtocolError");
+  REQUIRE(copy.Get("Code") == "8");
+}
+
+TEST_CASE("parse a message followed by data", "[protocol::message]")
+{
+  Message message("AllData\nIdentifier=get-1\nDataLength=5\nData\n");
+
+  REQUIRE(message.HasData());
+  REQUIRE(message.DataLength() == 5);
+}
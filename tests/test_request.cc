@@ -0,0 +1,86 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <fcp++/protocol/request.hpp>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+using fcp::protocol::Request;
+
+template<class Data>
+concept Sendable = requires(Data data) { data.ToRequest(); };
+
+TEST_CASE("ClientPutComplexDir walks a directory", "[protocol::request]")
+{
+  /* the header alone must not go through Client::Send or Client::Queue */
+  STATIC_REQUIRE_FALSE(Sendable<Request::ClientPutComplexDir>);
+
+  const fs::path directory = fs::temp_directory_path() / "fcp-test-putdir";
+  fs::remove_all(directory);
+  fs::create_directories(directory / "css");
+  std::ofstream(directory / "index.html") << "<html></html>";
+  std::ofstream(directory / "css" / "style.css") << "body{}";
+
+  Request::ClientPutComplexDir put("site", "CHK@");
+  put.AddDirectory(directory);
+
+  REQUIRE(put.Files.size() == 2);
+  REQUIRE(put.DataLength() == 19);
+
+  const std::string message = put.ToHeader();
+  REQUIRE(message.starts_with("ClientPutComplexDir\n"));
+  REQUIRE(message.ends_with("EndMessage\n"));
+  REQUIRE(message.find("Files.1.UploadFrom=direct\n") != std::string::npos);
+  REQUIRE((message.find("Files.0.Name=css/style.css\n") != std::string::npos ||
+           message.find("Files.1.Name=css/style.css\n") != std::string::npos));
+}
+
+TEST_CASE("ClientPutComplexDir header lists files in order",
+          "[protocol::request]")
+{
+  Request::ClientPutComplexDir put("site", "CHK@");
+  put.Files.push_back({ "index.html", "/dev/null", 1234 });
+  put.Files.push_back({ "empty.txt", "/dev/null", 0 });
+
+  const std::string header = put.ToHeader();
+  REQUIRE(header.starts_with("ClientPutComplexDir\n"));
+  REQUIRE(header.find("Identifier=site\n") != std::string::npos);
+  REQUIRE(header.ends_with("Files.0.Name=index.html\n"
+                           "Files.0.UploadFrom=direct\n"
+                           "Files.0.DataLength=1234\n"
+                           "Files.1.Name=empty.txt\n"
+                           "Files.1.UploadFrom=direct\n"
+                           "Files.1.DataLength=0\n"
+                           "EndMessage\n"));
+}
+
+TEST_CASE("FCPPluginMessage carries params and data", "[protocol::request]")
+{
+  Request::FCPPluginMessage call("plugins.HelloFCP.HelloFCP");
+  call.Identifier = "call-1";
+  call.Params["Message"] = "Ping";
+  call.Data = "payload";
+
+  const std::string message = call.ToRequest().ToString();
+  REQUIRE(message.starts_with("FCPPluginMessage\n"));
+  REQUIRE(message.find("Param.Message=Ping\n") != std::string::npos);
+  REQUIRE(message.find("DataLength=7\n") != std::string::npos);
+  REQUIRE(message.ends_with("\nData\npayload"));
+}
+
+TEST_CASE("AddPeer from an inline noderef", "[protocol::request]")
+{
+  auto peer = Request::AddPeer::FromNodeRef("identity=abc\r\n"
+                                            "myName=friend\r\n"
+                                            "End\r\n"
+                                            "ignored=yes\r\n");
+
+  REQUIRE(peer.NodeRef.size() == 2);
+  REQUIRE(peer.NodeRef[1].first == "myName");
+  REQUIRE(peer.NodeRef[1].second == "friend");
+
+  const std::string message = peer.ToRequest().ToString();
+  REQUIRE(message.find("identity=abc\n") != std::string::npos);
+  REQUIRE(message.find("Trust=NORMAL\n") != std::string::npos);
+  REQUIRE(message.find("ignored") == std::string::npos);
+}
@@ -0,0 +1,75 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <fcp++/stats.hpp>
+
+using namespace std::chrono_literals;
+
+TEST_CASE("count sent and received messages per name", "[stats]")
+{
+  fcp::Stats stats;
+
+  stats.RecordSent("ClientHello", 45);
+  stats.RecordSent("ListPeers", 20);
+  stats.RecordSent("ListPeers", 20);
+  stats.RecordReceived("NodeHello", 300);
+
+  auto snapshot = stats.GetSnapshot();
+  REQUIRE(snapshot.Sent.size() == 2);
+  REQUIRE(snapshot.Sent["ClientHello"].Messages == 1);
+  REQUIRE(snapshot.Sent["ListPeers"].Messages == 2);
+  REQUIRE(snapshot.Sent["ListPeers"].Bytes == 40);
+  REQUIRE(snapshot.Received.size() == 1);
+  REQUIRE(snapshot.Received["NodeHello"].Bytes == 300);
+}
+
+TEST_CASE("bucket write and completion latencies", "[stats]")
+{
+  fcp::Stats stats;
+
+  stats.RecordWrite(5us);
+  stats.RecordWrite(30us);
+  stats.RecordWrite(1s);
+  stats.RecordCompleted("AddPeer", 2ms);
+
+  auto snapshot = stats.GetSnapshot();
+  REQUIRE(snapshot.Writes.Count == 3);
+  REQUIRE(snapshot.Writes.Buckets[0] == 1);
+  REQUIRE(snapshot.Writes.Buckets[2] == 1);
+  REQUIRE(snapshot.Writes.Buckets.back() == 1);
+  REQUIRE(snapshot.Completion["AddPeer"].Count == 1);
+  REQUIRE(snapshot.Completion["AddPeer"].Sum == 2000);
+}
+
+TEST_CASE("track writes in progress", "[stats]")
+{
+  fcp::Stats stats;
+
+  {
+    fcp::Stats::Writing writing(stats);
+    REQUIRE(stats.GetSnapshot().WritesInProgress == 1);
+  }
+  REQUIRE(stats.GetSnapshot().WritesInProgress == 0);
+}
+
+TEST_CASE("dump in Prometheus text format", "[stats]")
+{
+  fcp::Stats stats;
+
+  stats.RecordSent("Shutdown", 18);
+  stats.RecordWrite(5us);
+  stats.RecordReceived("FCPPluginReply", 120);
+  stats.RecordCompleted("FCPPluginMessage", 40us);
+
+  const std::string dump = stats.ToPrometheus();
+  REQUIRE(dump.find("fcp_messages_sent_total{message=\"Shutdown\"} 1\n") !=
+          std::string::npos);
+  REQUIRE(dump.find("fcp_bytes_sent_total{message=\"Shutdown\"} 18\n") !=
+          std::string::npos);
+  REQUIRE(dump.find("fcp_bytes_received_total{message=\"FCPPluginReply\"} "
+                    "120\n") != std::string::npos);
+  REQUIRE(dump.find("fcp_write_latency_microseconds_bucket{le=\"+Inf\"} 1\n") !=
+          std::string::npos);
+  REQUIRE(dump.find("fcp_request_duration_microseconds_bucket{message="
+                    "\"FCPPluginMessage\",le=\"50\"} 1\n") != std::string::npos);
+  REQUIRE(dump.find("fcp_writes_in_progress 0\n") != std::string::npos);
+}